@@ -111,6 +111,146 @@ private:
   void compute_fastest_sort();
 };
 
+/**
+  Most significant byte first radix sort of record pointers, for sort keys
+  that are compared with memcmp() and all have the same length.
+
+  Every record pointer is paired with an 8-byte prefix of its key, starting
+  at the byte the current pass looks at. A pass distributes the pairs by the
+  top byte of the prefix and shifts the next key byte into the prefix, so
+  a pass reads one byte from each record. Buckets smaller than
+  INSERTION_SORT_MAX are finished with an insertion sort that compares the
+  prefixes first and only looks at the records on a prefix tie.
+*/
+
+class Radix_sort
+{
+public:
+  struct Prefixed_key
+  {
+    ulonglong prefix;
+    uchar *rec;
+  };
+
+  static const size_t INSERTION_SORT_MAX= 32;
+  /* Scratch space sort() needs per key, 32 bytes on 64-bit platforms */
+  static const size_t SCRATCH_PER_KEY= 2 * sizeof(Prefixed_key);
+
+  /**
+    Sorts keys[0..count-1] in place.
+    @param tmp   scratch space for 2 * count Prefixed_key,
+                 that is count * SCRATCH_PER_KEY bytes. It must be aligned
+                 for Prefixed_key: a caller that takes it from a byte
+                 buffer, such as the unused part of the sort buffer, has to
+                 reserve alignof(Prefixed_key) - 1 more bytes and align the
+                 start up.
+  */
+  static void sort(uchar **keys, size_t count, size_t key_length,
+                   Prefixed_key *tmp)
+  {
+    Prefixed_key *a= tmp, *b= tmp + count;
+    for (size_t i= 0; i < count; i++)
+    {
+      a[i].prefix= load_prefix(keys[i], 0, key_length);
+      a[i].rec= keys[i];
+    }
+    sort_pass(a, b, count, 0, key_length);
+    for (size_t i= 0; i < count; i++)
+      keys[i]= a[i].rec;
+  }
+
+private:
+  static ulonglong load_prefix(const uchar *key, size_t from, size_t length)
+  {
+    ulonglong prefix= 0;
+    for (size_t i= 0; i < 8; i++)
+      prefix= (prefix << 8) | (from + i < length ? key[from + i] : 0);
+    return prefix;
+  }
+
+  static bool less(const Prefixed_key &x, const Prefixed_key &y,
+                   size_t depth, size_t length)
+  {
+    if (x.prefix != y.prefix)
+      return x.prefix < y.prefix;
+    return depth + 8 < length &&
+           memcmp(x.rec + depth + 8, y.rec + depth + 8,
+                  length - depth - 8) < 0;
+  }
+
+  static void insertion_sort(Prefixed_key *a, size_t count, size_t depth,
+                             size_t length)
+  {
+    for (size_t i= 1; i < count; i++)
+    {
+      Prefixed_key x= a[i];
+      size_t j= i;
+      for (; j > 0 && less(x, a[j - 1], depth, length); j--)
+        a[j]= a[j - 1];
+      a[j]= x;
+    }
+  }
+
+  /*
+    a holds the keys, b is scratch space of the same size.
+    Only the smaller buckets are sorted recursively, the largest one is
+    handled by the loop, so the recursion is at most log2(count) deep.
+  */
+  static void sort_pass(Prefixed_key *a, Prefixed_key *b, size_t count,
+                        size_t depth, size_t length)
+  {
+    while (count >= 2 && depth < length)
+    {
+      if (count < INSERTION_SORT_MAX)
+      {
+        insertion_sort(a, count, depth, length);
+        return;
+      }
+      uint pos[256]= {0};
+      for (size_t i= 0; i < count; i++)
+        pos[a[i].prefix >> 56]++;
+      for (uint i= 0, start= 0; i < 256; i++)
+      {
+        uint n= pos[i];
+        pos[i]= start;
+        start+= n;
+      }
+
+      size_t next_byte= depth + 8;
+      for (size_t i= 0; i < count; i++)
+      {
+        Prefixed_key x= a[i];
+        uint bucket= (uint) (x.prefix >> 56);
+        x.prefix= (x.prefix << 8) |
+                  (next_byte < length ? x.rec[next_byte] : 0);
+        b[pos[bucket]++]= x;
+      }
+      memcpy(a, b, count * sizeof(*a));
+
+      /* Now pos[i] is the end of bucket i */
+      uint largest_start= 0, largest_count= 0;
+      for (uint i= 0, start= 0; i < 256; start= pos[i++])
+      {
+        uint n= pos[i] - start;
+        if (n > largest_count)
+        {
+          if (largest_count)
+            sort_pass(a + largest_start, b + largest_start, largest_count,
+                      depth + 1, length);
+          largest_start= start;
+          largest_count= n;
+        }
+        else if (n)
+          sort_pass(a + start, b + start, n, depth + 1, length);
+      }
+      a+= largest_start;
+      b+= largest_start;
+      count= largest_count;
+      depth++;
+    }
+  }
+};
+
 /**
   A wrapper class around the buffer used by filesort().
   The sort buffer is a contiguous chunk of memory,
@@ -156,6 +156,226 @@ public:
   ha_rows m_max_keys= 0;
 };
 
+
+/**
+  Tree of losers for k-way merging of sorted runs.
+
+  Runs are numbered 0..runs-1. Node i < runs of the tree keeps the run that
+  lost the comparison at that node, node 0 keeps the overall winner.
+  After the winner's run has advanced to its next key replay() restores
+  the tree with one comparison per level, where QUEUE needs about two.
+
+  Less is called as less(a, b) with two run numbers and must return true if
+  the current key of run a sorts before the current key of run b. An
+  exhausted run must sort after every other run.
+
+  The caller provides the node array, it must have room for 'runs' entries.
+*/
+
+template <class Less>
+class Loser_tree
+{
+public:
+  Loser_tree(uint *nodes, uint runs, Less less)
+    : m_nodes(nodes), m_runs(runs), m_less(less)
+  {
+    DBUG_ASSERT(runs > 0);
+  }
+
+  void build() { m_nodes[0]= build(1); }
+
+  /* The run with the smallest current key */
+  uint winner() const { return m_nodes[0]; }
+
+  void replay()
+  {
+    uint winner= m_nodes[0];
+    for (uint node= (winner + m_runs) / 2; node > 0; node/= 2)
+    {
+      if (m_less(m_nodes[node], winner))
+      {
+        uint tmp= m_nodes[node];
+        m_nodes[node]= winner;
+        winner= tmp;
+      }
+    }
+    m_nodes[0]= winner;
+  }
+
+private:
+  /* Leaves are nodes runs..2*runs-1, returns the winner of the subtree */
+  uint build(uint node)
+  {
+    if (node >= m_runs)
+      return node - m_runs;
+    uint left= build(2 * node), right= build(2 * node + 1);
+    if (m_less(right, left))
+    {
+      m_nodes[node]= left;
+      return right;
+    }
+    m_nodes[node]= right;
+    return left;
+  }
+
+  uint *m_nodes;
+  uint m_runs;
+  Less m_less;
+};
+
+
+/**
+  Bounded max-heap of {sort key, rowid} pairs for ORDER BY ... LIMIT.
+
+  Keeps the 'capacity' smallest keys seen so far, where capacity is the
+  LIMIT plus the OFFSET. Keys are fixed-length images that sort correctly
+  with memcmp(), stored with the rowid in one contiguous array, so there
+  are no row copies and no compare callbacks.
+
+  Once the heap is full its top key is the bound: the caller can build
+  only the first key part of a new row and drop the row if
+  rejects_prefix() says it cannot get in, before building the whole key.
+
+  After sort() the first OFFSET entries only tell where the result
+  starts. The caller must skip them and fetch rows by rowid for entries
+  OFFSET..elements()-1 only, that is at most LIMIT rnd_pos() calls.
+  It therefore needs the offset itself, not only select_limit_cnt, which
+  is LIMIT plus OFFSET.
+*/
+
+class Topn_heap
+{
+public:
+  Topn_heap()
+    : m_slots(NULL), m_capacity(0), m_count(0), m_key_length(0),
+      m_slot_length(0)
+  {}
+  ~Topn_heap() { my_free(m_slots); }
+
+  /*
+    true if a heap of this capacity fits into the sort memory, the same
+    limit check_if_pq_applicable() puts on the priority queue. The heap
+    must not be used when it doesn't.
+  */
+  static bool fits(ha_rows capacity, uint key_length, uint ref_length,
+                   size_t memory_available)
+  {
+    /* (capacity + 1) slots, without overflowing */
+    return capacity < memory_available / (key_length + ref_length);
+  }
+
+  /*
+    Returns true on out of memory. May be called again for another
+    execution, the previous array is freed.
+  */
+  bool init(ha_rows capacity, uint key_length, uint ref_length)
+  {
+    DBUG_ASSERT(capacity > 0);
+    my_free(m_slots);
+    m_capacity= capacity;
+    m_count= 0;
+    m_key_length= key_length;
+    m_slot_length= key_length + ref_length;
+    /* One extra slot as swap space */
+    m_slots= (uchar *) my_malloc(PSI_INSTRUMENT_ME,
+                                 (size_t) (capacity + 1) * m_slot_length,
+                                 MYF(MY_WME | MY_THREAD_SPECIFIC));
+    return m_slots == NULL;
+  }
+
+  bool is_full() const { return m_count == m_capacity; }
+  ha_rows elements() const { return m_count; }
+
+  /* true if no key starting with these bytes can enter the heap */
+  bool rejects_prefix(const uchar *prefix, uint length) const
+  {
+    DBUG_ASSERT(length <= m_key_length);
+    return is_full() && memcmp(prefix, slot(0), length) > 0;
+  }
+
+  /* Offers a row, key must be key_length bytes and ref ref_length bytes */
+  void push(const uchar *key, const uchar *ref)
+  {
+    if (!is_full())
+    {
+      store(m_count, key, ref);
+      sift_up(m_count++);
+    }
+    else if (memcmp(key, slot(0), m_key_length) < 0)
+    {
+      store(0, key, ref);
+      sift_down(0, m_count);
+    }
+  }
+
+  /*
+    Orders the kept entries by ascending key. After this the heap can
+    only be read with get_key()/get_ref().
+  */
+  void sort()
+  {
+    for (ha_rows n= m_count; n > 1; n--)
+    {
+      swap(0, n - 1);
+      sift_down(0, n - 1);
+    }
+  }
+
+  uchar *get_key(ha_rows i) const { return slot(i); }
+  uchar *get_ref(ha_rows i) const { return slot(i) + m_key_length; }
+
+private:
+  uchar *slot(ha_rows i) const { return m_slots + i * m_slot_length; }
+
+  void store(ha_rows i, const uchar *key, const uchar *ref)
+  {
+    memcpy(slot(i), key, m_key_length);
+    memcpy(slot(i) + m_key_length, ref, m_slot_length - m_key_length);
+  }
+
+  void swap(ha_rows i, ha_rows j)
+  {
+    uchar *tmp= slot(m_capacity);
+    memcpy(tmp, slot(i), m_slot_length);
+    memcpy(slot(i), slot(j), m_slot_length);
+    memcpy(slot(j), tmp, m_slot_length);
+  }
+
+  bool less(ha_rows i, ha_rows j) const
+  { return memcmp(slot(i), slot(j), m_key_length) < 0; }
+
+  void sift_up(ha_rows i)
+  {
+    while (i > 0 && less((i - 1) / 2, i))
+    {
+      swap(i, (i - 1) / 2);
+      i= (i - 1) / 2;
+    }
+  }
+
+  void sift_down(ha_rows i, ha_rows count)
+  {
+    for (;;)
+    {
+      ha_rows largest= i, left= 2 * i + 1, right= left + 1;
+      if (left < count && less(largest, left))
+        largest= left;
+      if (right < count && less(largest, right))
+        largest= right;
+      if (largest == i)
+        return;
+      swap(i, largest);
+      i= largest;
+    }
+  }
+
+  uchar *m_slots;
+  ha_rows m_capacity;
+  ha_rows m_count;
+  uint m_key_length;
+  uint m_slot_length;
+};
+
 typedef Bounds_checked_array<SORT_ADDON_FIELD> Addon_fields_array;
 typedef Bounds_checked_array<SORT_FIELD> Sort_keys_array;
 